@@ -9,10 +9,26 @@
 #include <string>       // std::string
 #include <sstream>      // std::istringstream, std::ostringstream
 #include <vector>       // std::vector
+#include <algorithm>    // std::min, std::max
 #include <fstream>      // std::ifstream, std::ofstream
 #include <iostream>     // std::cout
 #include <chrono>       // std::chrono для замера времени
 #include <ctime>        // time()
+#include <stdint.h>     // uint32_t, uint64_t для формата сжатого файла
+#include <thread>       // std::thread для параллельной распаковки
+#include <mutex>        // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <atomic>       // std::atomic
+#include <functional>   // std::function
+#include <unordered_map> // std::unordered_map для кеша дескрипторов
+
+// SIMD для битовой доски: AVX2 при /arch:AVX2, иначе SSE2 (всегда есть на x64)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LR_BITBOARD_SSE2
+#include <emmintrin.h>
+#endif
 
 // =========================
 // == ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ==
@@ -29,6 +45,11 @@ int configMethod = 2;                   // Метод работы с конфи
 // Имена файлов конфигурации и данных
 const char* configFileName = "config.txt";
 const char* dataFileName = "data.bin";
+const char* compressedDataFileName = "data.lz";  // Сжатая копия data.bin (блочный формат)
+
+// Параметры файла данных
+const size_t dataFileSize = 1024 * 1024;          // Размер несжатых данных (1 МБ)
+const size_t compressedBlockSize = 64 * 1024;     // Размер независимо сжимаемого блока
 
 // Прототипы функций для работы с конфигом
 bool LoadConfig_Method1();  // Метод 1: память (MMAP)
@@ -46,19 +67,273 @@ bool SaveConfig_Method4();  // Метод 4: WinAPI
 bool ParseConfigContent(const std::string& content);
 
 // Прототипы функций для бенчмаркинга
-void CreateDataFile();          // Создание файла
+void CreateDataFile(int randomPercent = 0, bool compressed = false); // Создание файла
 
-void ReadDataFile_Method1();    // Метод 1
-void ReadDataFile_Method2();    // Метод 2
-void ReadDataFile_Method3();    // Метод 3
-void ReadDataFile_Method4();    // Метод 4
+void ReadDataFile_Method1(const char* fileName = dataFileName);    // Метод 1
+void ReadDataFile_Method2(const char* fileName = dataFileName);    // Метод 2
+void ReadDataFile_Method3(const char* fileName = dataFileName);    // Метод 3
+void ReadDataFile_Method4(const char* fileName = dataFileName);    // Метод 4
+void ReadDataFile_Method5();    // Метод 5: сжатый файл, параллельная распаковка
 
 void BenchmarkDataFile();       // Бенчмарк чтения файла
+void BenchmarkCompressedDataFile(); // Бенчмарк сжатого файла против несжатого
+void ReadDataFile_Cached(const char* fileName); // Чтение через кеш дескрипторов
+void BenchmarkSmallFiles(int fileCount); // Бенчмарк множества мелких файлов
+void BenchmarkBitBoard();       // Бенчмарк поиска линий на битовой доске
+void BenchmarkSharedGrid(int maxWriters); // Бенчмарк общей сетки в разделяемой памяти
+void BenchmarkGridJournal();    // Бенчмарк журнала изменений сетки
+
+// Прототипы функций блочного LZ-кодека
+size_t LzCompressBound(size_t srcSize);
+size_t LzCompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+size_t LzDecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
 
 // Прототип оконной процедуры
 LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
 
+// ===================================================
+// == ПУЛ БУФЕРОВ ДЛЯ ЧТЕНИЯ ФАЙЛОВ                 ==
+// ===================================================
+// Буферы выделяются через VirtualAlloc (выравнивание на страницу),
+// не обнуляются и после освобождения остаются в пуле для следующего вызова.
+// По желанию используются большие страницы (нужна привилегия SeLockMemoryPrivilege).
+class BufferPool {
+public:
+    ~BufferPool() {
+        for (const Block& b : blocks)
+            VirtualFree(b.ptr, 0, MEM_RELEASE);
+    }
+
+    // Включает большие страницы; false — если система их не даёт
+    bool EnableLargePages() {
+        largePageSize = GetLargePageMinimum();
+        if (largePageSize == 0 || !EnableLockMemoryPrivilege()) {
+            largePageSize = 0;
+            return false;
+        }
+        return true;
+    }
+
+    // Выдаёт неинициализированный буфер не меньше size байт;
+    // capacity — его фактическая ёмкость
+    char* Acquire(size_t size, size_t& capacity) {
+        std::lock_guard<std::mutex> lock(mtx);
+        // Ищем свободный блок минимальной подходящей ёмкости
+        Block* best = nullptr;
+        for (Block& b : blocks) {
+            if (!b.inUse && b.capacity >= size && (!best || b.capacity < best->capacity))
+                best = &b;
+        }
+        if (best) {
+            best->inUse = true;
+            capacity = best->capacity;
+            return best->ptr;
+        }
+
+        Block b;
+        b.ptr = nullptr;
+        b.inUse = true;
+        // Сначала пробуем большие страницы, при отказе — обычные
+        if (largePageSize != 0) {
+            b.capacity = (size + largePageSize - 1) / largePageSize * largePageSize;
+            b.ptr = static_cast<char*>(VirtualAlloc(NULL, b.capacity,
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+        }
+        if (!b.ptr) {
+            b.capacity = (size + pageSize - 1) / pageSize * pageSize;
+            if (b.capacity == 0) b.capacity = pageSize;
+            b.ptr = static_cast<char*>(VirtualAlloc(NULL, b.capacity,
+                MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        }
+        if (!b.ptr)
+            return nullptr;
+        blocks.push_back(b);
+        capacity = b.capacity;
+        return b.ptr;
+    }
+
+    // Возвращает буфер в пул (память системе не отдаётся)
+    void Release(char* p) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (Block& b : blocks) {
+            if (b.ptr == p) {
+                b.inUse = false;
+                return;
+            }
+        }
+    }
+
+private:
+    struct Block {
+        char* ptr;        // начало буфера (выровнено на страницу)
+        size_t capacity;  // ёмкость в байтах
+        bool inUse;       // выдан ли буфер сейчас
+    };
+
+    // Большие страницы требуют привилегию блокировки памяти в токене процесса
+    static bool EnableLockMemoryPrivilege() {
+        HANDLE hToken = NULL;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken))
+            return false;
+        TOKEN_PRIVILEGES tp = {};
+        tp.PrivilegeCount = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        bool ok = LookupPrivilegeValueW(NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid)
+            && AdjustTokenPrivileges(hToken, FALSE, &tp, 0, NULL, NULL)
+            && GetLastError() != ERROR_NOT_ALL_ASSIGNED;
+        CloseHandle(hToken);
+        return ok;
+    }
+
+    std::vector<Block> blocks;
+    std::mutex mtx;
+    size_t pageSize = 4096;
+    size_t largePageSize = 0;   // 0 — большие страницы выключены
+};
+
+BufferPool readBufferPool;      // Общий пул для всех методов чтения
+bool bufferPoolEnabled = true;  // false — как раньше: новый обнулённый буфер на каждый вызов
+
+// Один буфер на поток перед общим пулом: повторные чтения в том же потоке
+// обходятся без мьютекса пула и поиска по списку блоков
+struct ThreadBufferCache {
+    char* ptr = nullptr;
+    size_t capacity = 0;
+    ~ThreadBufferCache() {
+        if (ptr)
+            readBufferPool.Release(ptr);
+    }
+};
+thread_local ThreadBufferCache threadBufferCache;
+
+// Буфер на время одного чтения: берётся из пула и возвращается в деструкторе
+class PooledBuffer {
+public:
+    explicit PooledBuffer(size_t size) : length(size), capacity(0), pooled(bufferPoolEnabled) {
+        if (!pooled) {
+            // Без пула повторяем поведение std::vector<char>(size): выделение + обнуление
+            ptr = new char[size]();
+            return;
+        }
+        ThreadBufferCache& cache = threadBufferCache;
+        if (cache.ptr && cache.capacity >= size) {
+            ptr = cache.ptr;
+            capacity = cache.capacity;
+            cache.ptr = nullptr;
+            cache.capacity = 0;
+        }
+        else {
+            ptr = readBufferPool.Acquire(size, capacity);
+        }
+    }
+    ~PooledBuffer() {
+        if (!pooled) {
+            delete[] ptr;
+            return;
+        }
+        if (!ptr)
+            return;
+        // Оставляем в кеше потока больший из буферов, меньший — в общий пул
+        ThreadBufferCache& cache = threadBufferCache;
+        if (cache.ptr && cache.capacity >= capacity) {
+            readBufferPool.Release(ptr);
+            return;
+        }
+        if (cache.ptr)
+            readBufferPool.Release(cache.ptr);
+        cache.ptr = ptr;
+        cache.capacity = capacity;
+    }
+    char* data() { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* ptr;
+    size_t length;
+    size_t capacity;   // ёмкость буфера из пула
+    bool pooled;
+};
+
+
+// ===================================================
+// == ПУЛ ПОТОКОВ                                   ==
+// ===================================================
+// Потоки создаются один раз; ParallelFor раздаёт индексы через атомарный счётчик
+// и ждёт, пока все потоки закончат текущее задание.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount) {
+        for (unsigned i = 0; i < threadCount; ++i)
+            threads.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cvWork.notify_all();
+        for (std::thread& t : threads)
+            t.join();
+    }
+
+    size_t Size() const { return threads.size(); }
+
+    // Выполняет fn(i) для i = 0..count-1 на потоках пула и ждёт завершения
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        std::unique_lock<std::mutex> lock(mtx);
+        job = &fn;
+        jobCount = count;
+        nextIndex = 0;
+        finishedWorkers = 0;
+        ++generation;
+        cvWork.notify_all();
+        cvDone.wait(lock, [this] { return finishedWorkers == threads.size(); });
+        job = nullptr;
+    }
+
+private:
+    void WorkerLoop() {
+        uint64_t seenGeneration = 0;
+        for (;;) {
+            const std::function<void(size_t)>* fn;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cvWork.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping)
+                    return;
+                seenGeneration = generation;
+                fn = job;
+                count = jobCount;
+            }
+            for (size_t i = nextIndex++; i < count; i = nextIndex++)
+                (*fn)(i);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (++finishedWorkers == threads.size())
+                    cvDone.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable cvWork;   // новое задание или остановка
+    std::condition_variable cvDone;   // все потоки закончили задание
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextIndex{ 0 };
+    size_t finishedWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+
 // ==========================================
 // == ФУНКЦИЯ: Парсинг содержимого конфига ==
 // ==========================================
@@ -336,8 +611,12 @@ bool LoadConfig_Method4() {
 
     // 2) Получаем размер файла в байтах
     DWORD fileSize = GetFileSize(hFile, NULL);
-    // Создаём буфер на fileSize+1 байт для данных плюс завершающий '\0'
-    std::vector<char> buffer(fileSize + 1);
+    // Берём из пула буфер на fileSize+1 байт для данных плюс завершающий '\0'
+    PooledBuffer buffer(fileSize + 1);
+    if (!buffer.data()) {
+        CloseHandle(hFile);
+        return false;
+    }
 
     // 3) Читаем содержимое файла в буфер
     DWORD readBytes = 0;
@@ -355,7 +634,7 @@ bool LoadConfig_Method4() {
     }
 
     // 4) Добавляем нулевой символ для безопасного создания строки
-    buffer[readBytes] = '\0';
+    buffer.data()[readBytes] = '\0';
 
     // 5) Освобождаем дескриптор файла
     CloseHandle(hFile);
@@ -409,10 +688,276 @@ bool SaveConfig_Method4() {
 // == БЕНЧМАРК ИЗ FҰாЦINE DATA FILE (1 МБ) ==
 // ====================================================
 
+// ===================================================
+// == БЛОЧНЫЙ LZ-КОДЕК (формат в духе LZ4)          ==
+// ===================================================
+// Последовательность: токен (старшие 4 бита — длина литералов,
+// младшие 4 бита — длина совпадения минус 4), расширение длины литералов
+// байтами 255, литералы, смещение (2 байта LE), расширение длины совпадения.
+// Последняя последовательность содержит только литералы.
+const size_t LZ_MIN_MATCH = 4;        // Минимальная длина совпадения
+const size_t LZ_LAST_LITERALS = 5;    // Хвост блока всегда пишется литералами
+const int LZ_HASH_BITS = 12;          // Размер хеш-таблицы: 4096 позиций
+const size_t LZ_MAX_OFFSET = 65535;   // Максимальное смещение (2 байта)
+
+static uint32_t LzRead32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Записывает расширение длины (байты 255 и остаток); false — нет места
+static bool LzWriteLength(unsigned char*& op, const unsigned char* oend, size_t len) {
+    while (len >= 255) {
+        if (op >= oend) return false;
+        *op++ = 255;
+        len -= 255;
+    }
+    if (op >= oend) return false;
+    *op++ = static_cast<unsigned char>(len);
+    return true;
+}
+
+// Максимальный размер сжатого блока для входа srcSize байт
+size_t LzCompressBound(size_t srcSize) {
+    return srcSize + srcSize / 255 + 16;
+}
+
+// Сжимает блок; возвращает размер сжатых данных или 0 при нехватке места
+size_t LzCompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity) {
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* ip = base;
+    const unsigned char* anchor = base;
+    const unsigned char* iend = base + srcSize;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+    const unsigned char* oend = op + dstCapacity;
+
+    // Хеш-таблица: позиция последнего вхождения 4-байтной последовательности
+    std::vector<uint32_t> table(size_t(1) << LZ_HASH_BITS, 0xFFFFFFFFu);
+
+    if (srcSize > LZ_MIN_MATCH + LZ_LAST_LITERALS) {
+        const unsigned char* matchLimit = iend - LZ_LAST_LITERALS;
+        while (ip + LZ_MIN_MATCH <= matchLimit) {
+            uint32_t seq = LzRead32(ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+            uint32_t refPos = table[h];
+            table[h] = static_cast<uint32_t>(ip - base);
+
+            const unsigned char* ref = base + refPos;
+            if (refPos == 0xFFFFFFFFu
+                || static_cast<size_t>(ip - ref) > LZ_MAX_OFFSET
+                || LzRead32(ref) != seq) {
+                ++ip;
+                continue;
+            }
+
+            // Продлеваем совпадение вперёд
+            const unsigned char* p = ip + LZ_MIN_MATCH;
+            const unsigned char* m = ref + LZ_MIN_MATCH;
+            while (p < matchLimit && *p == *m) { ++p; ++m; }
+
+            size_t litLen = static_cast<size_t>(ip - anchor);
+            size_t matchLen = static_cast<size_t>(p - ip) - LZ_MIN_MATCH;
+            size_t offset = static_cast<size_t>(ip - ref);
+
+            // Токен
+            if (op >= oend) return 0;
+            unsigned char* token = op++;
+            *token = static_cast<unsigned char>(
+                ((litLen >= 15 ? 15 : litLen) << 4) | (matchLen >= 15 ? 15 : matchLen));
+            if (litLen >= 15 && !LzWriteLength(op, oend, litLen - 15)) return 0;
+
+            // Литералы и смещение
+            if (static_cast<size_t>(oend - op) < litLen + 2) return 0;
+            memcpy(op, anchor, litLen);
+            op += litLen;
+            *op++ = static_cast<unsigned char>(offset & 0xFF);
+            *op++ = static_cast<unsigned char>(offset >> 8);
+            if (matchLen >= 15 && !LzWriteLength(op, oend, matchLen - 15)) return 0;
+
+            ip = p;
+            anchor = ip;
+        }
+    }
+
+    // Завершающие литералы
+    size_t litLen = static_cast<size_t>(iend - anchor);
+    if (op >= oend) return 0;
+    *op++ = static_cast<unsigned char>((litLen >= 15 ? 15 : litLen) << 4);
+    if (litLen >= 15 && !LzWriteLength(op, oend, litLen - 15)) return 0;
+    if (static_cast<size_t>(oend - op) < litLen) return 0;
+    memcpy(op, anchor, litLen);
+    op += litLen;
+
+    return static_cast<size_t>(op - reinterpret_cast<unsigned char*>(dst));
+}
+
+// Распаковывает блок; возвращает размер распакованных данных или 0 при ошибке
+size_t LzDecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* iend = ip + srcSize;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* obase = op;
+    unsigned char* oend = op + dstCapacity;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+
+        // Литералы
+        size_t litLen = token >> 4;
+        if (litLen == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) return 0;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if (static_cast<size_t>(iend - ip) < litLen || static_cast<size_t>(oend - op) < litLen)
+            return 0;
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        // Последняя последовательность — только литералы
+        if (ip >= iend)
+            break;
+
+        // Совпадение
+        if (iend - ip < 2) return 0;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - obase)) return 0;
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) return 0;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += LZ_MIN_MATCH;
+        if (static_cast<size_t>(oend - op) < matchLen) return 0;
+
+        const unsigned char* ref = op - offset;
+        if (offset >= matchLen) {
+            memcpy(op, ref, matchLen);
+            op += matchLen;
+        }
+        else {
+            // Перекрывающееся совпадение (например, серия одинаковых байт)
+            for (size_t i = 0; i < matchLen; ++i)
+                *op++ = *ref++;
+        }
+    }
+    return static_cast<size_t>(op - obase);
+}
+
+
+// =====================================================
+// == ФОРМАТ СЖАТОГО ФАЙЛА ДАННЫХ                     ==
+// =====================================================
+// [заголовок][индекс блоков][сжатые блоки...]
+// Блоки сжимаются независимо, поэтому их можно распаковывать параллельно.
+// Если блок не сжимается, он хранится как есть (compressedSize == rawSize).
+#pragma pack(push, 1)
+struct CompressedFileHeader {
+    char     magic[4];      // "LRZ1"
+    uint32_t blockSize;     // Размер несжатого блока
+    uint32_t blockCount;    // Количество блоков
+    uint64_t rawSize;       // Размер несжатых данных
+};
+struct CompressedBlockEntry {
+    uint64_t offset;          // Смещение сжатого блока от начала файла
+    uint32_t compressedSize;  // Размер сжатого блока
+    uint32_t rawSize;         // Размер несжатого блока
+};
+#pragma pack(pop)
+
+// Заполняет буфер данными: в каждом килобайте randomPercent% случайных байт,
+// остальное — нули. 0% даёт прежний файл из нулей, 100% практически не сжимается.
+static void FillDataPayload(std::vector<char>& buf, int randomPercent) {
+    uint32_t state = 0x12345678u;  // Фиксированное зерно: файл воспроизводим
+    size_t randomBytes = 1024 * static_cast<size_t>(randomPercent) / 100;
+    for (size_t chunk = 0; chunk < buf.size(); chunk += 1024) {
+        for (size_t i = 0; i < 1024 && chunk + i < buf.size(); ++i) {
+            if (i < randomBytes) {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                buf[chunk + i] = static_cast<char>(state & 0xFF);
+            }
+            else {
+                buf[chunk + i] = 0;
+            }
+        }
+    }
+}
+
+// Записывает данные в блочный сжатый формат
+static bool WriteCompressedDataFile(const char* fileName, const std::vector<char>& raw) {
+    uint32_t blockCount = static_cast<uint32_t>(
+        (raw.size() + compressedBlockSize - 1) / compressedBlockSize);
+
+    CompressedFileHeader header;
+    memcpy(header.magic, "LRZ1", 4);
+    header.blockSize = static_cast<uint32_t>(compressedBlockSize);
+    header.blockCount = blockCount;
+    header.rawSize = raw.size();
+
+    std::vector<CompressedBlockEntry> index(blockCount);
+    std::vector<char> packed;
+    std::vector<char> scratch(LzCompressBound(compressedBlockSize));
+    uint64_t offset = sizeof(header) + sizeof(CompressedBlockEntry) * blockCount;
+
+    // 1) Сжимаем каждый блок независимо
+    for (uint32_t i = 0; i < blockCount; ++i) {
+        size_t begin = static_cast<size_t>(i) * compressedBlockSize;
+        size_t rawSize = (std::min)(compressedBlockSize, raw.size() - begin);
+        size_t packedSize = LzCompressBlock(raw.data() + begin, rawSize,
+            scratch.data(), scratch.size());
+        const char* blockData = scratch.data();
+        if (packedSize == 0 || packedSize >= rawSize) {
+            // Несжимаемый блок храним как есть
+            packedSize = rawSize;
+            blockData = raw.data() + begin;
+        }
+        index[i].offset = offset + packed.size();
+        index[i].compressedSize = static_cast<uint32_t>(packedSize);
+        index[i].rawSize = static_cast<uint32_t>(rawSize);
+        packed.insert(packed.end(), blockData, blockData + packedSize);
+    }
+
+    // 2) Пишем заголовок, индекс и блоки
+    FILE* f = nullptr;
+    fopen_s(&f, fileName, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+        && (blockCount == 0
+            || fwrite(index.data(), sizeof(CompressedBlockEntry), blockCount, f) == blockCount)
+        && fwrite(packed.data(), 1, packed.size(), f) == packed.size();
+    fclose(f);
+    return ok;
+}
+
 // ===============================================
 // == ФУНКЦИЯ: Создание бинарного файла данных   ==
 // ===============================================
-void CreateDataFile() {
+// randomPercent — доля несжимаемых байт (0 — файл из нулей, как раньше);
+// compressed — записать блочный сжатый файл compressedDataFileName вместо data.bin
+void CreateDataFile(int randomPercent, bool compressed) {
+    // Формируем 1 МБ данных с заданной сжимаемостью
+    std::vector<char> buf(dataFileSize);
+    FillDataPayload(buf, randomPercent);
+
+    if (compressed) {
+        WriteCompressedDataFile(compressedDataFileName, buf);
+        return;
+    }
+
     // Указатель на файл для записи
     FILE* f = nullptr;
     // Открываем (или создаём) файл dataFileName в бинарном режиме для записи ("wb")
@@ -421,13 +966,10 @@ void CreateDataFile() {
     if (!f)
         return;
 
-    // Формируем буфер из 1024 нулевых байт
-    std::vector<char> buf(1024, 0);
-
     // Записываем в файл 1024 блока по 1024 байта (итого ~1 МБ)
-    for (int i = 0; i < 1024; ++i) {
+    for (size_t i = 0; i < buf.size(); i += 1024) {
         // fwrite(ptr, size_of_element, count, file)
-        fwrite(buf.data(), 1, buf.size(), f);
+        fwrite(buf.data() + i, 1, 1024, f);
     }
 
     // Закрываем файл после завершения записи
@@ -438,10 +980,10 @@ void CreateDataFile() {
 // =========================================================
 // == ФУНКЦИЯ: Чтение бинарного файла через MMAP (Method1) ==
 // =========================================================
-void ReadDataFile_Method1() {
-    // 1) Открываем файл dataFileName для чтения (read-only)
+void ReadDataFile_Method1(const char* fileName) {
+    // 1) Открываем файл fileName для чтения (read-only)
     HANDLE hFile = CreateFileA(
-        dataFileName,         // путь к файлу
+        fileName,             // путь к файлу
         GENERIC_READ,         // доступ: только чтение
         FILE_SHARE_READ,      // разрешаем другим процессам читать параллельно
         NULL,                 // атрибуты безопасности по умолчанию
@@ -449,6 +991,9 @@ void ReadDataFile_Method1() {
         FILE_ATTRIBUTE_NORMAL,// обычный файл
         NULL                  // шаблонный дескриптор не используется
     );
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+    DWORD fileSize = GetFileSize(hFile, NULL);
 
     // 2) Создаём объект отображения файла в память (read-only)
     HANDLE hMap = CreateFileMappingA(
@@ -458,6 +1003,11 @@ void ReadDataFile_Method1() {
         0, 0,                 // отображаем весь файл
         NULL                  // имя мапинга не требуется
     );
+    // Пустой файл отобразить нельзя — CreateFileMapping вернёт NULL
+    if (!hMap) {
+        CloseHandle(hFile);
+        return;
+    }
 
     // 3) Мапим (присоединяем) отображение в адресное пространство процесса
     char* p = reinterpret_cast<char*>(
@@ -467,11 +1017,16 @@ void ReadDataFile_Method1() {
             0, 0, 0           // отображаем весь файл
         )
         );
+    if (!p) {
+        CloseHandle(hMap);
+        CloseHandle(hFile);
+        return;
+    }
 
     // 4) Демонстрация чтения: читаем первый и последний байт
     // volatile гарантирует, что чтение не будет оптимизировано компилятором
     volatile char a = p[0];                     // первый байт файла
-    volatile char b = p[1024 * 1024 - 1];       // последний байт (1 MB - 1)
+    volatile char b = p[fileSize - 1];          // последний байт файла
 
     // 5) Очищаем отображение и закрываем дескрипторы
     UnmapViewOfFile(p);   // отвязываем область памяти
@@ -483,16 +1038,25 @@ void ReadDataFile_Method1() {
 // ==============================================
 // == ФУНКЦИЯ: Чтение бинарного файла (stdio)    ==
 // ==============================================
-void ReadDataFile_Method2() {
+void ReadDataFile_Method2(const char* fileName) {
     // Указатель на файл для чтения
     FILE* f = nullptr;
     // Открываем файл в бинарном режиме для чтения ("rb")
-    fopen_s(&f, dataFileName, "rb");
-    // Примечание: здесь нет проверки успешности открытия файла (f == nullptr),
-    // что в реальном коде стоит добавить, чтобы избежать UB при неудаче.
+    fopen_s(&f, fileName, "rb");
+    // Если файл не открылся — выходим
+    if (!f)
+        return;
 
-    // Создаём буфер размером 1 МБ (1024*1024 байт)
-    std::vector<char> buf(1024 * 1024);
+    // Узнаём размер файла и берём из пула неинициализированный буфер
+    // ровно под него (как в методе 4), а не фиксированный 1 МБ
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    PooledBuffer buf(static_cast<size_t>(size > 0 ? size : 0));
+    if (!buf.data()) {
+        fclose(f);
+        return;
+    }
 
     // Читаем данные из файла в буфер:
     // fread(ptr, size_of_element, count, file)
@@ -507,18 +1071,23 @@ void ReadDataFile_Method2() {
 // ======================================================
 // == ФУНКЦИЯ: Чтение бинарного файла через ifstream   ==
 // ======================================================
-void ReadDataFile_Method3() {
-    // Открываем файл dataFileName в бинарном режиме для чтения
+void ReadDataFile_Method3(const char* fileName) {
+    // Открываем файл fileName в бинарном режиме для чтения
     std::ifstream ifs(
-        dataFileName,         // имя файла
+        fileName,             // имя файла
         std::ios::binary       // режим: бинарный ввод
     );
     // Проверяем, удалось ли открыть файл (можно добавить обработку ошибки)
     if (!ifs.is_open())
         return;
 
-    // Создаём буфер размером 1 МБ (1024*1024 байт)
-    std::vector<char> buf(1024 * 1024);
+    // Узнаём размер файла и берём из пула буфер ровно под него
+    ifs.seekg(0, std::ios::end);
+    std::streamoff size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    PooledBuffer buf(static_cast<size_t>(size > 0 ? size : 0));
+    if (!buf.data())
+        return;
 
     // Читаем ровно buf.size() байт из файла в буфер
     // read(ptr, count) — читает count байт в указанный буфер
@@ -534,10 +1103,10 @@ void ReadDataFile_Method3() {
 // ================================================================
 // == МЕТОД 4: WinAPI низкоуровневое чтение бинарного файла      ==
 // ================================================================
-void ReadDataFile_Method4() {
-    // 1) Открываем файл dataFileName для чтения (read-only)
+void ReadDataFile_Method4(const char* fileName) {
+    // 1) Открываем файл fileName для чтения (read-only)
     HANDLE hFile = CreateFileA(
-        dataFileName,          // путь к файлу
+        fileName,              // путь к файлу
         GENERIC_READ,          // доступ: только чтение
         FILE_SHARE_READ,       // разрешаем другим процессам читать параллельно
         NULL,                  // атрибуты безопасности по умолчанию
@@ -556,8 +1125,12 @@ void ReadDataFile_Method4() {
         return;
     }
 
-    // 3) Выделяем буфер нужного размера (size.QuadPart байт)
-    std::vector<char> buf(static_cast<size_t>(size.QuadPart));
+    // 3) Берём из пула буфер нужного размера (size.QuadPart байт)
+    PooledBuffer buf(static_cast<size_t>(size.QuadPart));
+    if (!buf.data()) {
+        CloseHandle(hFile);
+        return;
+    }
 
     // 4) Считываем данные из файла в буфер
     // readBytes — фактическое число прочитанных байтов
@@ -577,6 +1150,266 @@ void ReadDataFile_Method4() {
 }
 
 
+// ====================================================================
+// == МЕТОД 5: Потоковое чтение сжатого файла с параллельной распаковкой ==
+// ====================================================================
+ThreadPool* decompressionPool = nullptr;  // Постоянные распаковщики (задаёт бенчмарк)
+
+void ReadDataFile_Method5() {
+    // 1) Открываем сжатый файл для последовательного чтения
+    HANDLE hFile = CreateFileA(
+        compressedDataFileName,   // путь к файлу
+        GENERIC_READ,             // доступ: только чтение
+        FILE_SHARE_READ,          // разрешаем другим процессам читать параллельно
+        NULL,                     // атрибуты безопасности по умолчанию
+        OPEN_EXISTING,            // открываем только если файл существует
+        FILE_FLAG_SEQUENTIAL_SCAN,// подсказка кешу: чтение строго по порядку
+        NULL                      // шаблонный дескриптор не используется
+    );
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    // 2) Читаем заголовок и проверяем его по размеру файла
+    CompressedFileHeader header;
+    DWORD readBytes = 0;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize)
+        || !ReadFile(hFile, &header, sizeof(header), &readBytes, NULL)
+        || readBytes != sizeof(header)
+        || memcmp(header.magic, "LRZ1", 4) != 0
+        || header.blockSize == 0
+        || header.rawSize > SIZE_MAX
+        || header.blockCount != (header.rawSize + header.blockSize - 1) / header.blockSize
+        || sizeof(header) + sizeof(CompressedBlockEntry) * static_cast<uint64_t>(header.blockCount)
+            > static_cast<uint64_t>(fileSize.QuadPart)) {
+        std::cerr << "[ReadData5] bad header in " << compressedDataFileName << std::endl;
+        CloseHandle(hFile);
+        return;
+    }
+
+    // 3) Читаем индекс блоков
+    std::vector<CompressedBlockEntry> index(header.blockCount);
+    DWORD indexBytes = static_cast<DWORD>(sizeof(CompressedBlockEntry) * header.blockCount);
+    if (indexBytes > 0
+        && (!ReadFile(hFile, index.data(), indexBytes, &readBytes, NULL) || readBytes != indexBytes)) {
+        CloseHandle(hFile);
+        return;
+    }
+
+    // Блоки должны лежать подряд сразу за индексом, каждый — со своим
+    // несжатым размером и внутри файла; иначе распаковка вышла бы за out
+    uint64_t dataStart = sizeof(header) + indexBytes;
+    uint64_t expectedOffset = dataStart;
+    for (uint32_t i = 0; i < header.blockCount; ++i) {
+        const CompressedBlockEntry& e = index[i];
+        uint64_t blockBegin = static_cast<uint64_t>(i) * header.blockSize;
+        uint64_t expectedRaw = (std::min)(static_cast<uint64_t>(header.blockSize),
+            header.rawSize - blockBegin);
+        if (e.offset != expectedOffset
+            || e.rawSize != expectedRaw
+            || e.compressedSize > e.rawSize
+            || (e.compressedSize == 0 && e.rawSize != 0)
+            || e.offset + e.compressedSize > static_cast<uint64_t>(fileSize.QuadPart)) {
+            std::cerr << "[ReadData5] bad index entry " << i << std::endl;
+            CloseHandle(hFile);
+            return;
+        }
+        expectedOffset += e.compressedSize;
+    }
+    uint64_t packedTotal = expectedOffset - dataStart;
+
+    PooledBuffer packed(static_cast<size_t>(packedTotal));
+    PooledBuffer out(static_cast<size_t>(header.rawSize));
+    if (!packed.data() || !out.data()) {
+        CloseHandle(hFile);
+        return;
+    }
+
+    // 4) Общее состояние читателя и распаковщиков
+    std::mutex mtx;
+    std::condition_variable cv;
+    uint32_t readyBlocks = 0;     // сколько блоков уже прочитано с диска
+    bool readFailed = false;
+    std::atomic<bool> decodeFailed{ false };
+
+    // Задание 0 — последовательное чтение блоков с диска,
+    // задание i > 0 — распаковка блока i - 1, как только он прочитан.
+    // Задание 0 всегда забирается первым, поэтому ожидание не может зависнуть.
+    auto job = [&](size_t task) {
+        if (task == 0) {
+            for (uint32_t i = 0; i < header.blockCount; ++i) {
+                const CompressedBlockEntry& e = index[i];
+                DWORD got = 0;
+                bool ok = ReadFile(hFile, packed.data() + (e.offset - dataStart),
+                    e.compressedSize, &got, NULL) && got == e.compressedSize;
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (ok)
+                        readyBlocks = i + 1;
+                    else
+                        readFailed = true;
+                }
+                cv.notify_all();
+                if (!ok)
+                    break;
+            }
+            return;
+        }
+
+        uint32_t i = static_cast<uint32_t>(task - 1);
+        {
+            // Ждём, пока читатель дойдёт до блока i
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return readyBlocks > i || readFailed; });
+            if (readyBlocks <= i)
+                return;
+        }
+        const CompressedBlockEntry& e = index[i];
+        const char* src = packed.data() + (e.offset - dataStart);
+        char* dst = out.data() + static_cast<size_t>(i) * header.blockSize;
+        if (e.compressedSize == e.rawSize)
+            memcpy(dst, src, e.rawSize);   // блок хранится несжатым
+        else if (LzDecompressBlock(src, e.compressedSize, dst, e.rawSize) != e.rawSize)
+            decodeFailed = true;
+    };
+
+    // 5) Распаковщики — постоянные потоки пула: создавать потоки на каждый
+    //    вызов дороже, чем распаковать 1 МБ. Без общего пула создаём свой.
+    if (decompressionPool) {
+        decompressionPool->ParallelFor(static_cast<size_t>(header.blockCount) + 1, job);
+    }
+    else {
+        ThreadPool pool((std::max)(1u, std::thread::hardware_concurrency()));
+        pool.ParallelFor(static_cast<size_t>(header.blockCount) + 1, job);
+    }
+
+    // 6) Закрываем дескриптор файла
+    CloseHandle(hFile);
+
+    if (readFailed || decodeFailed) {
+        std::cerr << "[ReadData5] " << (readFailed ? "read failed" : "corrupt block data")
+            << " in " << compressedDataFileName << std::endl;
+        return;
+    }
+
+    // При необходимости далее можно работать с распакованными данными в out
+}
+
+
+// ===================================================
+// == УПРАВЛЕНИЕ ФАЙЛОВЫМ КЕШЕМ (холодный/тёплый)    ==
+// ===================================================
+// В Windows нет mincore/posix_fadvise, поэтому:
+//  - резидентность в системном кеше не измеряется: рабочий набор своего
+//    отображения показывает лишь результат нашего же действия, а пробное
+//    чтение прогрело бы файл перед холодной итерацией. Вместо доли страниц
+//    бенчмарк печатает, какое действие выполнено и удалось ли оно;
+//  - вытеснение — отображение снимается, а файл открывается с
+//    FILE_FLAG_NO_BUFFERING: если других отображений нет, кеш файла обычно
+//    сбрасывается, но проверить это нельзя — холодный режим best-effort;
+//  - подкачка — PrefetchVirtualMemory и касание каждой страницы отображения;
+//  - закрепление — VirtualLock на отображении.
+class PageCacheControl {
+public:
+    explicit PageCacheControl(const char* fileName) : name(fileName) {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        pageSize = si.dwPageSize;
+    }
+    ~PageCacheControl() {
+        Unlock();
+        Unmap();
+    }
+
+    // Запрашивает вытеснение файла из кеша (аналог POSIX_FADV_DONTNEED).
+    // true не означает, что страницы действительно ушли из памяти;
+    // false — файл не открылся без буферизации, кеш точно остался прежним
+    bool Evict() {
+        Unlock();
+        Unmap();
+        HANDLE hFile = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+        CloseHandle(hFile);
+        return true;
+    }
+
+    // Загружает файл в память (аналог POSIX_FADV_WILLNEED / readahead)
+    bool Prefetch() {
+        if (!Map())
+            return false;
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = view;
+        range.NumberOfBytes = size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        // Касаемся каждой страницы, чтобы она попала в наше отображение
+        volatile char sink = 0;
+        for (size_t off = 0; off < size; off += pageSize)
+            sink ^= view[off];
+        return true;
+    }
+
+    // Закрепляет файл в памяти (аналог mlock)
+    bool Lock() {
+        if (locked)
+            return true;
+        if (!Prefetch())
+            return false;
+        // VirtualLock ограничен минимальным рабочим набором — расширяем его
+        SIZE_T minWs = 0, maxWs = 0;
+        if (GetProcessWorkingSetSize(GetCurrentProcess(), &minWs, &maxWs))
+            SetProcessWorkingSetSize(GetCurrentProcess(), minWs + size + 16 * pageSize,
+                maxWs + size + 16 * pageSize);
+        locked = VirtualLock(view, size) != FALSE;
+        return locked;
+    }
+
+    void Unlock() {
+        if (locked)
+            VirtualUnlock(view, size);
+        locked = false;
+    }
+
+private:
+    bool Map() {
+        if (view)
+            return true;
+        hFile = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+        size = GetFileSize(hFile, NULL);
+        hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        view = hMap ? static_cast<char*>(MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!view) {
+            Unmap();
+            return false;
+        }
+        return true;
+    }
+
+    void Unmap() {
+        if (view) UnmapViewOfFile(view);
+        if (hMap) CloseHandle(hMap);
+        if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+        view = nullptr;
+        hMap = NULL;
+        hFile = INVALID_HANDLE_VALUE;
+    }
+
+    std::string name;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMap = NULL;
+    char* view = nullptr;
+    size_t size = 0;
+    size_t pageSize = 4096;
+    bool locked = false;
+};
+
+bool lockDataFile = false;  // -lock: в тёплом режиме закреплять data.bin в памяти
+
+
 // =================================================================
 // == ФУНКЦИЯ: Бенчмарк чтения 1 МБ файла разными методами        ==
 // =================================================================
@@ -594,39 +1427,1300 @@ void BenchmarkDataFile() {
     // 4) Псевдоним для высокоточного таймера
     using clk = std::chrono::high_resolution_clock;
 
-    // 5) Перебираем четыре метода чтения
+    // 5) Три прохода с заданным состоянием кеша перед каждой итерацией:
+    //    тёплый кеш без пула (как раньше) и с пулом — разница даёт цену выделения
+    //    и обнуления памяти; холодный кеш с пулом — цену чтения с диска
+    struct Pass { bool pool; bool cold; const char* title; };
+    const Pass passes[] = {
+        { false, false, u8"--- Без пула (выделение на каждый вызов), тёплый кеш ---\n" },
+        { true,  false, u8"--- С пулом буферов, тёплый кеш ---\n" },
+        { true,  true,  u8"--- С пулом буферов, холодный кеш ---\n" },
+    };
+    const int passCount = sizeof(passes) / sizeof(passes[0]);
+    double avg_ms[passCount][5] = { {0} };
+    int failed[passCount][5] = { {0} };     // итерации, где кеш не удалось подготовить
+    bool poolWasEnabled = bufferPoolEnabled;
+    {
+        PageCacheControl cache(dataFileName);
+        for (int pass = 0; pass < passCount; ++pass) {
+            bufferPoolEnabled = passes[pass].pool;
+            std::cout << passes[pass].title;
+
+            // 6) Перебираем четыре метода чтения
+            for (int method = 1; method <= 4; ++method) {
+                double total_ms = 0;  // аккумулируем общее время для метода
+
+                // 7) Повторяем 10 прогонов для каждого метода
+                for (int i = 1; i <= 10; ++i) {
+                    // Приводим кеш в нужное состояние и запоминаем, удалось ли это
+                    const char* state;
+                    if (passes[pass].cold) {
+                        if (cache.Evict()) {
+                            state = u8"сброс запрошен";
+                        } else {
+                            state = u8"сброс НЕ запрошен";
+                            ++failed[pass][method];
+                        }
+                    } else if (lockDataFile && cache.Lock()) {
+                        state = u8"закреплён";
+                    } else if (cache.Prefetch()) {
+                        state = u8"подкачан";
+                    } else {
+                        state = u8"подкачка НЕ удалась";
+                        ++failed[pass][method];
+                    }
+
+                    // Засекаем время начала
+                    auto t0 = clk::now();
+
+                    // Вызываем соответствующий метод чтения
+                    switch (method) {
+                    case 1: ReadDataFile_Method1(); break;
+                    case 2: ReadDataFile_Method2(); break;
+                    case 3: ReadDataFile_Method3(); break;
+                    case 4: ReadDataFile_Method4(); break;
+                    }
+
+                    // Засекаем время окончания
+                    auto t1 = clk::now();
+                    // Вычисляем миллисекунды, прошедшие между t0 и t1
+                    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+                    total_ms += ms;  // добавляем к общему времени
+
+                    // Выводим время данного прогона
+                    std::cout << u8"Метод " << method
+                        << u8", итерация " << i
+                        << u8": " << ms << u8" ms (кеш " << state << u8")\n";
+                }
+
+                // 8) После 10 прогонов выводим среднее время для метода
+                avg_ms[pass][method] = total_ms / 10.0;
+                std::cout << u8"Среднее время для метода " << method << u8": "
+                    << avg_ms[pass][method] << u8" ms за 10 прогонов";
+                if (failed[pass][method])
+                    std::cout << u8" (кеш не подготовлен в " << failed[pass][method] << u8" из 10)";
+                std::cout << u8"\n\n";
+            }
+        }
+    }
+    bufferPoolEnabled = poolWasEnabled;
+
+    // Доля времени итерации, которая уходила на выделение и обнуление буфера
+    std::cout << u8"=== Доля выделения памяти во времени итерации ===\n";
     for (int method = 1; method <= 4; ++method) {
-        double total_ms = 0;  // аккумулируем общее время для метода
-
-        // 6) Повторяем 10 прогонов для каждого метода
-        for (int i = 1; i <= 10; ++i) {
-            // Засекаем время начала
-            auto t0 = clk::now();
-
-            // Вызываем соответствующий метод чтения
-            switch (method) {
-            case 1: ReadDataFile_Method1(); break;
-            case 2: ReadDataFile_Method2(); break;
-            case 3: ReadDataFile_Method3(); break;
-            case 4: ReadDataFile_Method4(); break;
+        std::cout << u8"Метод " << method << u8": " << avg_ms[0][method] << u8" ms -> "
+            << avg_ms[1][method] << u8" ms, выделение ";
+        // Метод 1 читает через отображение и буфер не выделяет — разница здесь лишь шум
+        if (method == 1) {
+            std::cout << u8"n/a\n";
+            continue;
+        }
+        double saved = avg_ms[0][method] - avg_ms[1][method];
+        std::cout << u8"~" << (avg_ms[0][method] > 0 ? saved * 100.0 / avg_ms[0][method] : 0.0) << u8"%\n";
+    }
+    std::cout << u8"\n";
+
+    // Холодный кеш против тёплого (оба прохода с пулом)
+    std::cout << u8"=== Холодный кеш против тёплого ===\n"
+        << u8"(холодный режим best-effort: сброс кеша запрашивается, но не проверяется —\n"
+        << u8" резидентность страниц в Windows этим бенчмарком не измеряется)\n";
+    for (int method = 1; method <= 4; ++method) {
+        std::cout << u8"Метод " << method << u8": холодный " << avg_ms[2][method]
+            << u8" ms, тёплый " << avg_ms[1][method] << u8" ms"
+            << (failed[2][method] ? u8" (сброс кеша не удалось запросить во всех итерациях)" : u8"") << u8"\n";
+    }
+    std::cout << u8"\n";
+
+    // 9) Сравниваем сжатый формат с несжатым на разной сжимаемости данных
+    BenchmarkCompressedDataFile();
+}
+
+
+// =====================================================================
+// == ФУНКЦИЯ: Бенчмарк сжатого файла (Method5) против несжатого (Method4) ==
+// =====================================================================
+void BenchmarkCompressedDataFile() {
+    using clk = std::chrono::high_resolution_clock;
+    const int iterations = 10;
+    const int percents[] = { 0, 25, 50, 75, 100 };  // доля несжимаемых байт
+
+    std::cout << u8"=== Бенчмарк сжатого формата: эффективная скорость чтения 1 МБ ===\n";
+
+    // Потоки-распаковщики создаются один раз, вне замеров
+    ThreadPool pool((std::max)(1u, std::thread::hardware_concurrency()));
+    decompressionPool = &pool;
+
+    for (int percent : percents) {
+        // 1) Готовим одинаковые данные в несжатом и сжатом виде
+        CreateDataFile(percent, false);
+        CreateDataFile(percent, true);
+
+        // Размер сжатого файла через GetFileSizeEx
+        LARGE_INTEGER packedSize = {};
+        HANDLE hFile = CreateFileA(compressedDataFileName, GENERIC_READ, FILE_SHARE_READ,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile != INVALID_HANDLE_VALUE) {
+            GetFileSizeEx(hFile, &packedSize);
+            CloseHandle(hFile);
+        }
+        double ratio = packedSize.QuadPart > 0
+            ? static_cast<double>(dataFileSize) / packedSize.QuadPart : 0.0;
+
+        std::cout << u8"Случайных байт " << percent << u8"%: степень сжатия " << ratio
+            << u8" (" << packedSize.QuadPart << u8" байт)\n";
+
+        // 2) Замеряем оба метода: с тёплым кешем — цена распаковки,
+        //    с холодным — случай, когда узкое место в чтении с диска
+        for (int cold = 0; cold <= 1; ++cold) {
+            PageCacheControl rawCache(dataFileName);
+            PageCacheControl packedCache(compressedDataFileName);
+            double raw_ms = 0, packed_ms = 0;
+            int failed = 0;   // итерации, где сброс кеша не удалось запросить
+            for (int i = 0; i < iterations; ++i) {
+                if (cold && !rawCache.Evict())
+                    ++failed;
+                auto t0 = clk::now();
+                ReadDataFile_Method4();
+                auto t1 = clk::now();
+                if (cold && !packedCache.Evict())
+                    ++failed;
+                auto t2 = clk::now();
+                ReadDataFile_Method5();
+                auto t3 = clk::now();
+                raw_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                packed_ms += std::chrono::duration<double, std::milli>(t3 - t2).count();
             }
+            raw_ms /= iterations;
+            packed_ms /= iterations;
+
+            // 3) Эффективная скорость — несжатые мегабайты в секунду
+            double mb = static_cast<double>(dataFileSize) / (1024.0 * 1024.0);
+            std::cout << (cold ? u8"  Холодный кеш (сброс запрошен, best-effort)" : u8"  Тёплый кеш")
+                << (failed ? u8", сброс не запрошен в части итераций" : u8"") << u8":\n"
+                << u8"    Метод 4 (несжатый): " << raw_ms << u8" ms, "
+                << (raw_ms > 0 ? mb / (raw_ms / 1000.0) : 0.0) << u8" МБ/с\n"
+                << u8"    Метод 5 (сжатый):   " << packed_ms << u8" ms, "
+                << (packed_ms > 0 ? mb / (packed_ms / 1000.0) : 0.0) << u8" МБ/с\n";
+        }
+    }
+    std::cout << u8"\n";
+
+    decompressionPool = nullptr;
+
+    // 4) Удаляем сжатую копию и возвращаем исходный файл данных из нулей
+    DeleteFileA(compressedDataFileName);
+    CreateDataFile();
+}
 
-            // Засекаем время окончания
-            auto t1 = clk::now();
-            // Вычисляем миллисекунды, прошедшие между t0 и t1
-            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
-            total_ms += ms;  // добавляем к общему времени
 
-            // 7) Выводим время данного прогона
-            std::cout << u8"Метод " << method
-                << u8", итерация " << i
-                << u8": " << ms << u8" ms\n";
+// ===================================================
+// == КЕШ ОТКРЫТЫХ ФАЙЛОВ И ОТОБРАЖЕНИЙ             ==
+// ===================================================
+// Файл открывается и отображается в память при первом обращении,
+// повторные чтения обходятся без CreateFile/CreateFileMapping/MapViewOfFile.
+class FileHandleCache {
+public:
+    ~FileHandleCache() { Clear(); }
+
+    // Возвращает отображение файла и его размер; nullptr — файл не открылся
+    const char* Get(const std::string& path, size_t& size) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = entries.find(path);
+            if (it != entries.end()) {
+                size = it->second.size;
+                return it->second.view;
+            }
         }
 
-        // 8) После 10 прогонов выводим среднее время для метода
-        std::cout << u8"Среднее время для метода " << method << u8": "
-            << (total_ms / 10.0) << u8" ms за 10 прогонов\n\n";
+        // Открываем вне блокировки, чтобы потоки не ждали чужих открытий
+        Entry e;
+        if (!Open(path, e))
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto res = entries.emplace(path, e);
+        if (!res.second)
+            Close(e);   // другой поток успел открыть тот же файл
+        size = res.first->second.size;
+        return res.first->second.view;
+    }
+
+    // Закрывает все отображения и дескрипторы
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& kv : entries)
+            Close(kv.second);
+        entries.clear();
     }
+
+private:
+    struct Entry {
+        HANDLE hFile;
+        HANDLE hMap;
+        const char* view;
+        size_t size;
+    };
+
+    static bool Open(const std::string& path, Entry& e) {
+        e.hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (e.hFile == INVALID_HANDLE_VALUE)
+            return false;
+        e.size = GetFileSize(e.hFile, NULL);
+        e.hMap = CreateFileMappingA(e.hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!e.hMap) {
+            CloseHandle(e.hFile);
+            return false;
+        }
+        e.view = static_cast<const char*>(MapViewOfFile(e.hMap, FILE_MAP_READ, 0, 0, 0));
+        if (!e.view) {
+            CloseHandle(e.hMap);
+            CloseHandle(e.hFile);
+            return false;
+        }
+        return true;
+    }
+
+    static void Close(Entry& e) {
+        UnmapViewOfFile(e.view);
+        CloseHandle(e.hMap);
+        CloseHandle(e.hFile);
+    }
+
+    std::unordered_map<std::string, Entry> entries;
+    std::mutex mtx;
+};
+
+FileHandleCache fileHandleCache;   // Кеш для режима «мелкие файлы»
+
+
+// ==========================================================
+// == ФУНКЦИЯ: Чтение файла через кеш дескрипторов         ==
+// ==========================================================
+void ReadDataFile_Cached(const char* fileName) {
+    // 1) Берём готовое отображение (файл открывается только в первый раз)
+    size_t size = 0;
+    const char* view = fileHandleCache.Get(fileName, size);
+    if (!view)
+        return;
+
+    // 2) Копируем данные в буфер из пула, как остальные методы
+    PooledBuffer buf(size);
+    if (buf.data())
+        memcpy(buf.data(), view, size);
+}
+
+
+// ==========================================================
+// == ФУНКЦИЯ: Генерация множества мелких конфиг-файлов    ==
+// ==========================================================
+// Файлы раскладываются по каталогам smallfiles\dNNN, не более 256 файлов в каталоге.
+std::vector<std::string> CreateSmallFiles(int fileCount) {
+    const int filesPerDir = 256;
+    std::vector<std::string> paths;
+    CreateDirectoryA("smallfiles", NULL);
+
+    for (int i = 0; i < fileCount; ++i) {
+        char dir[MAX_PATH];
+        char path[MAX_PATH];
+        sprintf_s(dir, sizeof(dir), "smallfiles\\d%03d", i / filesPerDir);
+        if (i % filesPerDir == 0)
+            CreateDirectoryA(dir, NULL);
+        sprintf_s(path, sizeof(path), "%s\\f%05d.cfg", dir, i);
+
+        // Содержимое в формате config.txt
+        std::ostringstream oss;
+        oss << "gridSize=" << (i % MAX_GRID + 1) << "\n"
+            << "windowWidth=" << (320 + i % 100) << "\n"
+            << "windowHeight=" << (240 + i % 100) << "\n"
+            << "bgColor=" << (i % 256) << " " << (i * 7 % 256) << " " << (i * 13 % 256) << "\n"
+            << "gridColor=" << (i * 3 % 256) << " " << (i * 5 % 256) << " " << (i * 11 % 256) << "\n";
+        std::string data = oss.str();
+
+        FILE* f = nullptr;
+        fopen_s(&f, path, "wb");
+        if (!f)
+            continue;
+        fwrite(data.c_str(), 1, data.size(), f);
+        fclose(f);
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// Удаляет файлы и каталоги, созданные CreateSmallFiles
+void RemoveSmallFiles(int fileCount) {
+    const int filesPerDir = 256;
+    for (int i = 0; i < fileCount; ++i) {
+        char path[MAX_PATH];
+        sprintf_s(path, sizeof(path), "smallfiles\\d%03d\\f%05d.cfg", i / filesPerDir, i);
+        DeleteFileA(path);
+    }
+    for (int d = 0; d * filesPerDir < fileCount; ++d) {
+        char dir[MAX_PATH];
+        sprintf_s(dir, sizeof(dir), "smallfiles\\d%03d", d);
+        RemoveDirectoryA(dir);
+    }
+    RemoveDirectoryA("smallfiles");
+}
+
+
+// =====================================================================
+// == ФУНКЦИЯ: Бенчмарк множества мелких файлов (последовательно и в пуле) ==
+// =====================================================================
+void BenchmarkSmallFiles(int fileCount) {
+    using clk = std::chrono::high_resolution_clock;
+    const int passes = 3;
+
+    // 1) Генерируем файлы
+    std::vector<std::string> paths = CreateSmallFiles(fileCount);
+    if (paths.empty()) {
+        RemoveSmallFiles(fileCount);
+        return;
+    }
+
+    ThreadPool pool((std::max)(1u, std::thread::hardware_concurrency()));
+
+    std::cout << u8"=== Бенчмарк мелких файлов: " << paths.size() << u8" файлов, "
+        << pool.Size() << u8" потоков в пуле ===\n";
+
+    // Метод 5 здесь — чтение через кеш дескрипторов и отображений
+    auto readOne = [&](int method, size_t i) {
+        const char* path = paths[i].c_str();
+        switch (method) {
+        case 1: ReadDataFile_Method1(path); break;
+        case 2: ReadDataFile_Method2(path); break;
+        case 3: ReadDataFile_Method3(path); break;
+        case 4: ReadDataFile_Method4(path); break;
+        case 5: ReadDataFile_Cached(path); break;
+        }
+    };
+
+    // 2) Кеш заполняем заранее: в замер попадают только повторные чтения
+    auto t0 = clk::now();
+    for (size_t i = 0; i < paths.size(); ++i)
+        readOne(5, i);
+    double fill_ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+    std::cout << u8"Заполнение кеша: " << fill_ms << u8" ms\n";
+
+    // 3) Для каждого метода — последовательный и параллельный прогон
+    for (int method = 1; method <= 5; ++method) {
+        double serial_ms = 0, parallel_ms = 0;
+        for (int pass = 0; pass < passes; ++pass) {
+            auto s0 = clk::now();
+            for (size_t i = 0; i < paths.size(); ++i)
+                readOne(method, i);
+            auto s1 = clk::now();
+            pool.ParallelFor(paths.size(), [&](size_t i) { readOne(method, i); });
+            auto s2 = clk::now();
+            serial_ms += std::chrono::duration<double, std::milli>(s1 - s0).count();
+            parallel_ms += std::chrono::duration<double, std::milli>(s2 - s1).count();
+        }
+        serial_ms /= passes;
+        parallel_ms /= passes;
+
+        double files = static_cast<double>(paths.size());
+        std::string label = (method == 5) ? u8"Кеш дескрипторов" : u8"Метод " + std::to_string(method);
+        std::cout << label << u8": последовательно " << (serial_ms > 0 ? files * 1000.0 / serial_ms : 0.0)
+            << u8" файлов/с, пул " << (parallel_ms > 0 ? files * 1000.0 / parallel_ms : 0.0)
+            << u8" файлов/с\n";
+    }
+    std::cout << u8"\n";
+
+    // 4) Освобождаем дескрипторы кеша и удаляем файлы
+    fileHandleCache.Clear();
+    RemoveSmallFiles(fileCount);
+}
+
+
+// ===================================================
+// == БИТОВАЯ ДОСКА И ПОИСК K В РЯД                 ==
+// ===================================================
+// Для каждого игрока — свой битовый массив, клетка (r, c) хранится в бите
+// r * stride + c, где stride = width + 1. Лишний пустой столбец не даёт линиям
+// «перескакивать» с конца строки на начало следующей, поэтому все четыре
+// направления сводятся к сдвигу всего массива на 1, stride, stride + 1 и stride - 1.
+class BitBoard {
+public:
+    BitBoard() { Reset(0, 0); }
+    BitBoard(int w, int h) { Reset(w, h); }
+
+    // Пересоздаёт пустую доску w x h
+    void Reset(int w, int h) {
+        width = w;
+        height = h;
+        stride = w + 1;
+        size_t words = (static_cast<size_t>(height) * stride + 63) / 64;
+        for (int p = 0; p < 2; ++p)
+            bits[p].assign(words, 0);
+        scratch.assign(words, 0);
+    }
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    // Содержимое клетки: 0 — пусто, 1 — круг, 2 — крест
+    int Get(int row, int col) const {
+        size_t i = Index(row, col);
+        if (TestBit(bits[0], i)) return 1;
+        if (TestBit(bits[1], i)) return 2;
+        return 0;
+    }
+
+    // Ставит фишку игрока (1 или 2; 0 — очистить) и проверяет только
+    // четыре линии через эту клетку. true — образовалось k в ряд.
+    bool Place(int row, int col, int player, int k) {
+        if (row < 0 || row >= height || col < 0 || col >= width)
+            return false;
+        size_t i = Index(row, col);
+        ClearBit(bits[0], i);
+        ClearBit(bits[1], i);
+        if (player != 1 && player != 2)
+            return false;
+        const std::vector<uint64_t>& b = bits[player - 1];
+        SetBit(bits[player - 1], i);
+
+        static const int dirs[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+        for (const auto& d : dirs) {
+            int run = 1;
+            // Вперёд и назад по направлению, не дальше k - 1 клеток
+            for (int s = 1; run < k; ++s) {
+                int r = row + d[0] * s, c = col + d[1] * s;
+                if (r < 0 || r >= height || c < 0 || c >= width || !TestBit(b, Index(r, c))) break;
+                ++run;
+            }
+            for (int s = 1; run < k; ++s) {
+                int r = row - d[0] * s, c = col - d[1] * s;
+                if (r < 0 || r >= height || c < 0 || c >= width || !TestBit(b, Index(r, c))) break;
+                ++run;
+            }
+            if (run >= k)
+                return true;
+        }
+        return false;
+    }
+
+    // Полная проверка доски: есть ли у игрока k в ряд в любом направлении.
+    // m &= m >> (n * shift) удваивает длину найденных отрезков, так что
+    // нужно O(log k) проходов по массиву на направление.
+    bool HasLine(int player, int k) const {
+        if ((player != 1 && player != 2) || k < 1)
+            return false;
+        const std::vector<uint64_t>& b = bits[player - 1];
+        const size_t shifts[4] = {
+            1, static_cast<size_t>(stride),
+            static_cast<size_t>(stride) + 1, static_cast<size_t>(stride) - 1 };
+        for (size_t shift : shifts) {
+            if (shift == 0)
+                continue;   // доска шириной 0
+            scratch = b;
+            int n = 1;
+            while (n * 2 <= k) {
+                ShiftRightAnd(scratch, shift * n);
+                n *= 2;
+            }
+            if (n < k)
+                ShiftRightAnd(scratch, shift * (k - n));
+            if (AnyBit(scratch))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    size_t Index(int row, int col) const {
+        return static_cast<size_t>(row) * stride + col;
+    }
+    static bool TestBit(const std::vector<uint64_t>& v, size_t i) {
+        return (v[i >> 6] >> (i & 63)) & 1;
+    }
+    static void SetBit(std::vector<uint64_t>& v, size_t i) {
+        v[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+    static void ClearBit(std::vector<uint64_t>& v, size_t i) {
+        v[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+
+    // m[i] &= (m >> shift)[i] на месте. Источник всегда правее приёмника,
+    // поэтому проход по возрастанию читает ещё не изменённые слова.
+    static void ShiftRightAnd(std::vector<uint64_t>& m, size_t shift) {
+        const size_t n = m.size();
+        const size_t ws = shift >> 6;          // сдвиг в словах
+        const unsigned bs = shift & 63;        // сдвиг в битах внутри слова
+        uint64_t* p = m.data();
+        size_t i = 0;
+#if defined(__AVX2__)
+        // По 4 слова за раз; сдвиг на 64 в SIMD даёт 0, так что bs == 0 не особый случай
+        const __m128i cntLo = _mm_cvtsi32_si128(static_cast<int>(bs));
+        const __m128i cntHi = _mm_cvtsi32_si128(static_cast<int>(64 - bs));
+        for (; i + ws + 5 <= n; i += 4) {
+            __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + ws));
+            __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + ws + 1));
+            __m256i v = _mm256_or_si256(_mm256_srl_epi64(lo, cntLo), _mm256_sll_epi64(hi, cntHi));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), _mm256_and_si256(d, v));
+        }
+#elif defined(LR_BITBOARD_SSE2)
+        // По 2 слова за раз (SSE2)
+        const __m128i cntLo = _mm_cvtsi32_si128(static_cast<int>(bs));
+        const __m128i cntHi = _mm_cvtsi32_si128(static_cast<int>(64 - bs));
+        for (; i + ws + 3 <= n; i += 2) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + ws));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + ws + 1));
+            __m128i v = _mm_or_si128(_mm_srl_epi64(lo, cntLo), _mm_sll_epi64(hi, cntHi));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_and_si128(d, v));
+        }
+#endif
+        // Хвост (и весь массив без SIMD)
+        for (; i < n; ++i) {
+            uint64_t lo = (i + ws < n) ? p[i + ws] : 0;
+            uint64_t hi = (i + ws + 1 < n) ? p[i + ws + 1] : 0;
+            uint64_t v = bs ? (lo >> bs) | (hi << (64 - bs)) : lo;
+            p[i] &= v;
+        }
+    }
+
+    static bool AnyBit(const std::vector<uint64_t>& m) {
+        size_t i = 0;
+        const size_t n = m.size();
+#if defined(__AVX2__)
+        for (; i + 4 <= n; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m.data() + i));
+            if (!_mm256_testz_si256(v, v)) return true;
+        }
+#elif defined(LR_BITBOARD_SSE2)
+        for (; i + 2 <= n; i += 2) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m.data() + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF) return true;
+        }
+#endif
+        for (; i < n; ++i)
+            if (m[i]) return true;
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    int stride = 1;
+    std::vector<uint64_t> bits[2];              // [0] — круги, [1] — кресты
+    mutable std::vector<uint64_t> scratch;      // рабочий массив для HasLine
+};
+
+BitBoard gameBoard;     // Битовое представление grid для поиска линий
+int winLength = 5;      // Сколько фишек в ряд нужно для победы (-k N)
+
+
+// =====================================================================
+// == ФУНКЦИЯ: Бенчмарк битовой доски (ходов в секунду)              ==
+// =====================================================================
+void BenchmarkBitBoard() {
+    using clk = std::chrono::high_resolution_clock;
+    const int sizes[] = { 15, 100, 1000, 4000 };
+    const int k = 5;
+
+    std::cout << u8"=== Бенчмарк битовой доски: " << k << u8" в ряд ===\n";
+
+    for (int side : sizes) {
+        BitBoard board(side, side);
+        uint32_t state = 0x9E3779B9u;   // xorshift: одинаковые ходы при каждом запуске
+        auto next = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        };
+
+        // 1) Инкрементальная проверка после каждого хода
+        const int moves = 1000000;
+        int wins = 0;
+        auto t0 = clk::now();
+        for (int m = 0; m < moves; ++m) {
+            int r = static_cast<int>(next() % side);
+            int c = static_cast<int>(next() % side);
+            if (board.Place(r, c, 1 + (m & 1), k))
+                ++wins;
+        }
+        double inc_ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+
+        // 2) Полная проверка всей доски сдвигами (для сравнения)
+        int scans = side <= 100 ? 10000 : (side <= 1000 ? 200 : 20);
+        int found = 0;
+        auto t1 = clk::now();
+        for (int s = 0; s < scans; ++s)
+            found += board.HasLine(1 + (s & 1), k) ? 1 : 0;
+        double scan_ms = std::chrono::duration<double, std::milli>(clk::now() - t1).count();
+
+        std::cout << side << u8"x" << side
+            << u8": инкрементально " << (inc_ms > 0 ? moves * 1000.0 / inc_ms : 0.0)
+            << u8" ходов/с (линий: " << wins << u8"), полный скан "
+            << (scan_ms > 0 ? scans * 1000.0 / scan_ms : 0.0) << u8" досок/с\n";
+    }
+    std::cout << u8"\n";
+}
+
+
+// ===================================================
+// == ЖУРНАЛ ИЗМЕНЕНИЙ СЕТКИ (append-only, MMAP)    ==
+// ===================================================
+// Каждое изменение клетки дописывается записью фиксированного размера в один
+// из двух отображённых в память сегментов журнала (<имя>.0 и <имя>.1). Фоновый
+// поток раз в несколько миллисекунд сбрасывает накопившиеся записи на диск
+// одним FlushViewOfFile (групповая фиксация). Когда активный сегмент
+// перерастает порог, поток под блокировкой лишь меняет сегменты местами, а
+// затем без блокировки сворачивает замороженный сегмент в базовый образ
+// (временный файл + атомарная подмена) и только после этого очищает его.
+// Записи на месте не сдвигаются, поэтому сбой на любом шаге ничего не теряет:
+// при старте читаются образ и оба сегмента, а порядок применения задаёт номер
+// изменения — для каждой клетки помним номер последнего применённого и
+// применяем запись, только если её номер больше.
+#pragma pack(push, 1)
+struct JournalHeader {
+    char     magic[4];              // "LRJ1"
+    uint32_t capacity;              // ёмкость сегмента в записях
+    volatile LONG recordCount;      // сколько записей сейчас в сегменте
+    uint32_t reserved[13];          // до 64 байт
+};
+struct JournalRecord {
+    int32_t  row;
+    int32_t  col;
+    int32_t  value;
+    uint32_t sequence;              // сквозной номер изменения (0 — пустая запись)
+};
+struct BaseImageHeader {
+    char     magic[4];              // "LRB1"
+    uint32_t lastSequence;          // последнее изменение, вошедшее в образ
+};
+#pragma pack(pop)
+
+class GridJournal {
+public:
+    ~GridJournal() { Close(); }
+
+    // Открывает образ и оба сегмента, восстанавливает состояние в cells
+    // и запускает фоновый поток фиксации и сжатия
+    bool Open(const char* baseName, const char* journalName, int (*cells)[MAX_GRID]) {
+        Close();
+        baseFileName = baseName;
+        memset(baseCells, 0, sizeof(baseCells));
+        memset(cellSequence, 0, sizeof(cellSequence));
+        lastSequence = 0;
+        imageSequence = 0;
+
+        // 1) Базовый образ (если есть)
+        FILE* f = nullptr;
+        fopen_s(&f, baseName, "rb");
+        if (f) {
+            BaseImageHeader bh;
+            int32_t image[MAX_GRID][MAX_GRID];
+            if (fread(&bh, sizeof(bh), 1, f) == 1 && memcmp(bh.magic, "LRB1", 4) == 0
+                && fread(image, sizeof(image), 1, f) == 1) {
+                memcpy(baseCells, image, sizeof(baseCells));
+                lastSequence = imageSequence = bh.lastSequence;
+                for (auto& row : cellSequence)
+                    std::fill(std::begin(row), std::end(row), imageSequence);
+            }
+            fclose(f);
+        }
+
+        // 2) Оба сегмента; записи проигрываем поверх образа в порядке номеров
+        uint32_t topSequence[2] = { 0, 0 };
+        for (int i = 0; i < 2; ++i) {
+            if (!OpenSegment(segments[i], SegmentName(journalName, i).c_str())) {
+                Close();
+                return false;
+            }
+            const Segment& seg = segments[i];
+            uint32_t count = (std::min)(static_cast<uint32_t>(seg.header->recordCount), journalCapacity);
+            for (uint32_t j = 0; j < count; ++j) {
+                const JournalRecord& r = seg.records[j];
+                if (!ValidRecord(r))
+                    continue;
+                ApplyRecord(r);   // в образ попадёт при следующем сжатии
+                topSequence[i] = (std::max)(topSequence[i], r.sequence);
+            }
+            seg.header->recordCount = static_cast<LONG>(count);
+        }
+        lastSequence = (std::max)(lastSequence, (std::max)(topSequence[0], topSequence[1]));
+        memcpy(cells, baseCells, sizeof(baseCells));
+
+        // 3) Писать продолжаем в сегмент с более новыми записями; другой,
+        //    если в нём что-то осталось, сворачиваем
+        active = topSequence[1] > topSequence[0] ? 1 : 0;
+        frozen = segments[1 - active].header->recordCount > 0 ? 1 - active : -1;
+
+        // 4) Фоновый поток фиксации и сжатия
+        stopping = false;
+        dropping = false;
+        compactRequested = static_cast<uint32_t>(segments[active].header->recordCount) >= compactThreshold;
+        worker = std::thread([this] { WorkerLoop(); });
+        return true;
+    }
+
+    // Дописывает изменение клетки; сама запись на диск — в фоновом потоке.
+    // Никогда не ждёт: если активный сегмент полон, а второй ещё не свёрнут,
+    // изменение отбрасывается и возвращается false
+    bool Append(int row, int col, int value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (active < 0)
+            return false;
+        Segment& seg = segments[active];
+        uint32_t index = static_cast<uint32_t>(seg.header->recordCount);
+        if (index >= journalCapacity) {
+            if (!dropping)
+                std::cerr << "[GridJournal] journal full, dropping edits" << std::endl;
+            dropping = true;
+            ++droppedEdits;
+            RequestCompaction();
+            return false;
+        }
+        dropping = false;
+        JournalRecord& r = seg.records[index];
+        r.row = row;
+        r.col = col;
+        r.value = value;
+        r.sequence = ++lastSequence;
+        seg.header->recordCount = static_cast<LONG>(index + 1);
+        dirty = true;
+        if (index + 1 >= compactThreshold)
+            RequestCompaction();
+        return true;
+    }
+
+    // Останавливает поток (с финальной фиксацией) и закрывает сегменты
+    void Close() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            workCv.notify_one();
+            worker.join();
+        }
+        CloseSegment(segments[0]);
+        CloseSegment(segments[1]);
+        active = -1;
+        frozen = -1;
+    }
+
+    bool IsOpen() const { return active >= 0; }
+    size_t Compactions() const { return compactions; }
+    size_t DroppedEdits() const { return droppedEdits; }
+
+    // Удаляет образ и оба сегмента журнала
+    static void RemoveFiles(const char* baseName, const char* journalName) {
+        DeleteFileA(baseName);
+        DeleteFileA(SegmentName(journalName, 0).c_str());
+        DeleteFileA(SegmentName(journalName, 1).c_str());
+    }
+
+    static const uint32_t journalCapacity = 256 * 1024;  // 4 МБ записей на сегмент
+    static const uint32_t compactThreshold = 32 * 1024;  // порог сжатия (ограничивает восстановление)
+    static const DWORD commitIntervalMs = 5;             // окно групповой фиксации
+    static const DWORD maxRetryMs = 1000;                // предел паузы между неудачными сжатиями
+
+private:
+    struct Segment {
+        HANDLE hFile = INVALID_HANDLE_VALUE;
+        HANDLE hMap = NULL;
+        JournalHeader* header = nullptr;
+        JournalRecord* records = nullptr;
+    };
+
+    static std::string SegmentName(const char* journalName, int index) {
+        return std::string(journalName) + (index ? ".1" : ".0");
+    }
+
+    // Открывает файл сегмента фиксированного размера и отображает его в память
+    static bool OpenSegment(Segment& seg, const char* name) {
+        seg.hFile = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+            NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (seg.hFile == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER want;
+        want.QuadPart = sizeof(JournalHeader) + static_cast<LONGLONG>(journalCapacity) * sizeof(JournalRecord);
+        LARGE_INTEGER have;
+        if (!GetFileSizeEx(seg.hFile, &have) || have.QuadPart < want.QuadPart) {
+            if (!SetFilePointerEx(seg.hFile, want, NULL, FILE_BEGIN) || !SetEndOfFile(seg.hFile))
+                return false;
+        }
+        seg.hMap = CreateFileMappingA(seg.hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+        char* base = seg.hMap ? static_cast<char*>(MapViewOfFile(seg.hMap, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+        if (!base)
+            return false;
+        seg.header = reinterpret_cast<JournalHeader*>(base);
+        seg.records = reinterpret_cast<JournalRecord*>(base + sizeof(JournalHeader));
+
+        // Новый или чужой файл — начинаем пустой сегмент
+        if (memcmp(seg.header->magic, "LRJ1", 4) != 0 || seg.header->capacity != journalCapacity) {
+            memset(seg.header, 0, sizeof(JournalHeader));
+            memcpy(seg.header->magic, "LRJ1", 4);
+            seg.header->capacity = journalCapacity;
+        }
+        return true;
+    }
+
+    static void CloseSegment(Segment& seg) {
+        if (seg.header)
+            UnmapViewOfFile(seg.header);
+        if (seg.hMap)
+            CloseHandle(seg.hMap);
+        if (seg.hFile != INVALID_HANDLE_VALUE)
+            CloseHandle(seg.hFile);
+        seg = Segment();
+    }
+
+    static bool ValidRecord(const JournalRecord& r) {
+        return r.sequence != 0 && r.row >= 0 && r.row < MAX_GRID
+            && r.col >= 0 && r.col < MAX_GRID && r.value >= 0 && r.value <= 2;
+    }
+
+    // Применяет запись к baseCells, если она новее уже применённой для клетки
+    bool ApplyRecord(const JournalRecord& r) {
+        if (r.sequence <= cellSequence[r.row][r.col])
+            return false;
+        baseCells[r.row][r.col] = r.value;
+        cellSequence[r.row][r.col] = r.sequence;
+        return true;
+    }
+
+    // Вызывается под mtx; будит поток один раз, а не на каждой записи
+    void RequestCompaction() {
+        if (!compactRequested) {
+            compactRequested = true;
+            workCv.notify_one();
+        }
+    }
+
+    // Под mtx выполняются только смена сегментов и учёт; сброс на диск
+    // и сжатие идут без блокировки, Append их не ждёт
+    void WorkerLoop() {
+        using clk = std::chrono::steady_clock;
+        DWORD retryMs = commitIntervalMs;
+        clk::time_point nextFold = clk::now();
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            // Пока второй сегмент не свёрнут, сменить сегменты нельзя —
+            // запрос сжатия тогда не будит поток, чтобы он не крутился вхолостую
+            workCv.wait_for(lock, std::chrono::milliseconds(commitIntervalMs),
+                [this] { return stopping || (compactRequested && frozen < 0); });
+
+            // Смена сегментов: пишем в пустой, заполненный замораживаем
+            if (compactRequested && frozen < 0) {
+                compactRequested = false;
+                if (segments[active].header->recordCount > 0) {
+                    frozen = active;
+                    active = 1 - active;
+                }
+            }
+
+            // Сжатие замороженного сегмента; после неудачи — с растущей паузой
+            if (frozen >= 0 && !stopping && clk::now() >= nextFold) {
+                Segment& seg = segments[frozen];
+                lock.unlock();
+                bool folded = FoldSegment(seg);
+                lock.lock();
+                if (folded) {
+                    frozen = -1;
+                    ++compactions;
+                    retryMs = commitIntervalMs;
+                } else {
+                    ++failedCompactions;
+                    std::cerr << "[GridJournal] base image write failed: " << GetLastError() << std::endl;
+                    nextFold = clk::now() + std::chrono::milliseconds(retryMs);
+                    retryMs = (std::min)(retryMs * 2, maxRetryMs);
+                }
+            }
+
+            // Групповая фиксация: один сброс на все записи за интервал
+            if (dirty) {
+                dirty = false;
+                Segment& seg = segments[active];   // меняет его только этот поток
+                lock.unlock();
+                FlushViewOfFile(seg.header, 0);
+                FlushFileBuffers(seg.hFile);
+                lock.lock();
+            }
+            if (stopping)
+                return;
+        }
+    }
+
+    // Сворачивает замороженный сегмент в базовый образ и очищает его.
+    // Вызывается без mtx: в замороженный сегмент никто не пишет
+    bool FoldSegment(Segment& seg) {
+        // Записи сегмента должны быть на диске независимо от успеха образа
+        FlushViewOfFile(seg.header, 0);
+        FlushFileBuffers(seg.hFile);
+
+        uint32_t n = (std::min)(static_cast<uint32_t>(seg.header->recordCount), journalCapacity);
+        uint32_t foldedSequence = imageSequence;
+        for (uint32_t i = 0; i < n; ++i) {
+            const JournalRecord& r = seg.records[i];
+            if (!ValidRecord(r))
+                continue;
+            ApplyRecord(r);   // уже применённые при открытии пропускаются
+            foldedSequence = (std::max)(foldedSequence, r.sequence);
+        }
+        if (!WriteBaseImage(foldedSequence))
+            return false;   // сегмент остаётся заморожен, попробуем позже
+        imageSequence = foldedSequence;
+
+        // Образ на диске — теперь записи сегмента можно стереть. Сбой посреди
+        // очистки безопасен: оставшиеся записи не новее образа и пропустятся
+        memset(seg.records, 0, n * sizeof(JournalRecord));
+        seg.header->recordCount = 0;
+        FlushViewOfFile(seg.header, sizeof(JournalHeader) + n * sizeof(JournalRecord));
+        FlushFileBuffers(seg.hFile);
+        return true;
+    }
+
+    // Пишет образ во временный файл и атомарно подменяет им старый
+    bool WriteBaseImage(uint32_t sequence) {
+        std::string tmpName = baseFileName + ".tmp";
+        HANDLE hOut = CreateFileA(tmpName.c_str(), GENERIC_WRITE, 0, NULL,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hOut == INVALID_HANDLE_VALUE)
+            return false;
+        BaseImageHeader bh;
+        memcpy(bh.magic, "LRB1", 4);
+        bh.lastSequence = sequence;
+        int32_t image[MAX_GRID][MAX_GRID];
+        memcpy(image, baseCells, sizeof(image));
+        DWORD w1 = 0, w2 = 0;
+        bool ok = WriteFile(hOut, &bh, sizeof(bh), &w1, NULL) && w1 == sizeof(bh)
+            && WriteFile(hOut, image, sizeof(image), &w2, NULL) && w2 == sizeof(image)
+            && FlushFileBuffers(hOut);
+        CloseHandle(hOut);
+        return ok && MoveFileExA(tmpName.c_str(), baseFileName.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    }
+
+    std::string baseFileName;
+    Segment segments[2];
+    int active = -1;                // сегмент, в который дописывает Append
+    int frozen = -1;                // сегмент, ожидающий сжатия (-1 — нет)
+    int baseCells[MAX_GRID][MAX_GRID] = { {0} };   // образ + свёрнутые записи
+    uint32_t cellSequence[MAX_GRID][MAX_GRID] = { {0} };   // номер последнего изменения клетки в baseCells
+    uint32_t lastSequence = 0;      // последний выданный номер изменения
+    uint32_t imageSequence = 0;     // lastSequence базового образа на диске
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable workCv;     // пора фиксировать/сжимать или остановиться
+    bool stopping = false;
+    bool compactRequested = false;
+    bool dirty = false;
+    bool dropping = false;              // идут отбрасывания (сообщаем один раз)
+    size_t compactions = 0;
+    size_t failedCompactions = 0;
+    size_t droppedEdits = 0;
+};
+
+const uint32_t GridJournal::journalCapacity;
+const uint32_t GridJournal::compactThreshold;
+const DWORD GridJournal::commitIntervalMs;
+const DWORD GridJournal::maxRetryMs;
+
+const char* gridBaseFileName = "grid.base";         // Базовый образ сетки
+const char* gridJournalFileName = "grid.journal";   // Журнал изменений
+GridJournal gridJournal;                            // Журнал для своей сетки (не -shm)
+
+
+// =====================================================================
+// == ФУНКЦИЯ: Бенчмарк журнала: цена записи и время восстановления  ==
+// =====================================================================
+void BenchmarkGridJournal() {
+    using clk = std::chrono::high_resolution_clock;
+    const char* baseName = "journal_bench.base";
+    const char* journalName = "journal_bench.journal";
+    const int edits = 1000000;
+    static int cells[MAX_GRID][MAX_GRID];
+    static int expected[MAX_GRID][MAX_GRID];
+
+    GridJournal::RemoveFiles(baseName, journalName);
+
+    std::cout << u8"=== Бенчмарк журнала сетки: " << edits << u8" изменений ===\n";
+
+    // 1) Запись
+    GridJournal journal;
+    if (!journal.Open(baseName, journalName, cells)) {
+        std::cerr << "[GridJournal] open failed: " << GetLastError() << std::endl;
+        return;
+    }
+    memset(expected, 0, sizeof(expected));
+    uint32_t state = 0x2545F491u;
+    int dropped = 0;
+    auto t0 = clk::now();
+    for (int i = 0; i < edits; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int r = (state >> 4) % MAX_GRID, c = (state >> 12) % MAX_GRID, v = 1 + (state >> 24) % 2;
+        if (journal.Append(r, c, v))
+            expected[r][c] = v;
+        else
+            ++dropped;
+    }
+    double append_ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+    size_t compactions = journal.Compactions();
+    journal.Close();
+
+    // 2) Восстановление: образ + хвост журнала
+    auto t1 = clk::now();
+    GridJournal recovered;
+    bool ok = recovered.Open(baseName, journalName, cells);
+    double recover_ms = std::chrono::duration<double, std::milli>(clk::now() - t1).count();
+    recovered.Close();
+    ok = ok && memcmp(cells, expected, sizeof(cells)) == 0;
+
+    std::cout << u8"Запись: " << (append_ms * 1e6 / edits) << u8" нс на изменение, сжатий: "
+        << compactions << u8"\n";
+    if (dropped)
+        std::cout << u8"Отброшено изменений (журнал полон): " << dropped << u8"\n";
+    std::cout << u8"Восстановление: " << recover_ms << u8" ms"
+        << (ok ? u8"" : u8" (состояние не совпало!)") << u8"\n\n";
+
+    GridJournal::RemoveFiles(baseName, journalName);
+}
+
+
+// ===================================================
+// == ОБЩАЯ СЕТКА В РАЗДЕЛЯЕМОЙ ПАМЯТИ (-shm)       ==
+// ===================================================
+// Сетка лежит в именованном отображении (CreateFileMapping без файла), поэтому
+// несколько процессов видят одну доску. Клетки меняются через
+// InterlockedCompareExchange, после каждого изменения растёт счётчик sequence:
+// читателю достаточно сравнить одно число, чтобы узнать, что доска изменилась.
+const char* sharedGridName = "Local\\LR2v3SharedGrid";           // Для окна
+const char* sharedGridBenchName = "Local\\LR2v3SharedGridBench"; // Для бенчмарка
+const char* sharedGridStartEventName = "Local\\LR2v3SharedGridStart";
+const UINT_PTR sharedGridTimerId = 1;   // Таймер проверки счётчика в окне
+
+struct SharedGrid {
+    volatile LONG sequence;                     // число изменений клеток
+    volatile LONG size;                         // размер сетки (задаёт первый процесс)
+    volatile LONG readyWriters;                 // писатели, дошедшие до стартового события
+    volatile LONG cells[MAX_GRID][MAX_GRID];    // 0 – пусто, 1 – круг, 2 – крест
+};
+
+HANDLE hSharedGridMap = NULL;       // Объект отображения общей сетки
+SharedGrid* sharedGrid = nullptr;   // nullptr — сетка своя (grid)
+LONG sharedGridSeenSequence = 0;    // Последний увиденный окном sequence
+
+// Открывает (или создаёт) общую сетку; preferredSize применяется, если мы первые
+SharedGrid* OpenSharedGrid(const char* name, int preferredSize, HANDLE& hMap) {
+    // Тот же путь, что у LoadConfig_Method1, только отображение без файла
+    hMap = CreateFileMappingA(
+        INVALID_HANDLE_VALUE,     // страницы из файла подкачки
+        NULL,                     // атрибуты безопасности по умолчанию
+        PAGE_READWRITE,           // чтение и запись
+        0, sizeof(SharedGrid),    // размер отображения
+        name                      // имя видно другим процессам
+    );
+    if (!hMap)
+        return nullptr;
+    SharedGrid* sg = static_cast<SharedGrid*>(
+        MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedGrid)));
+    if (!sg) {
+        CloseHandle(hMap);
+        hMap = NULL;
+        return nullptr;
+    }
+    // Новое отображение заполнено нулями; размер фиксирует первый успевший процесс
+    InterlockedCompareExchange(&sg->size, preferredSize, 0);
+    return sg;
+}
+
+void CloseSharedGrid(SharedGrid*& sg, HANDLE& hMap) {
+    if (sg)
+        UnmapViewOfFile(sg);
+    if (hMap)
+        CloseHandle(hMap);
+    sg = nullptr;
+    hMap = NULL;
+}
+
+// Чтение клетки из текущей сетки (своей или общей)
+int GetCell(int row, int col) {
+    return sharedGrid ? static_cast<int>(sharedGrid->cells[row][col]) : grid[row][col];
+}
+
+// Запись клетки; true — значение действительно изменилось
+bool SetCell(int row, int col, int value) {
+    if (!sharedGrid) {
+        if (grid[row][col] == value)
+            return false;
+        // Изменение, которое журнал не принял, не показываем — иначе
+        // экран разойдётся с тем, что восстановится после перезапуска
+        if (gridJournal.IsOpen() && !gridJournal.Append(row, col, value))
+            return false;
+        grid[row][col] = value;
+        return true;
+    }
+    volatile LONG* cell = &sharedGrid->cells[row][col];
+    for (;;) {
+        LONG old = *cell;
+        if (old == value)
+            return false;
+        if (InterlockedCompareExchange(cell, value, old) == old) {
+            InterlockedIncrement(&sharedGrid->sequence);
+            return true;
+        }
+    }
+}
+
+// Перестраивает битовую доску по текущей сетке; true — у кого-то есть линия
+bool RebuildGameBoard() {
+    gameBoard.Reset(gridSize, gridSize);
+    for (int r = 0; r < gridSize; ++r)
+        for (int c = 0; c < gridSize; ++c)
+            gameBoard.Place(r, c, GetCell(r, c), 0);
+    int k = (std::min)(winLength, gridSize);
+    return gameBoard.HasLine(1, k) || gameBoard.HasLine(2, k);
+}
+
+
+// ===============================================================
+// == ФУНКЦИЯ: Процесс-писатель для бенчмарка общей сетки       ==
+// ===============================================================
+// Запускается как LR2v3.exe -shmwriter N: ждёт стартового события и делает
+// N изменений случайных клеток через CAS.
+int RunSharedGridWriter(int updates) {
+    HANDLE hMap = NULL;
+    SharedGrid* sg = OpenSharedGrid(sharedGridBenchName, MAX_GRID, hMap);
+    HANDLE hStart = CreateEventA(NULL, TRUE, FALSE, sharedGridStartEventName);
+    if (!sg || !hStart) {
+        CloseSharedGrid(sg, hMap);
+        return 1;
+    }
+    // Сообщаем родителю о готовности и ждём общего старта
+    InterlockedIncrement(&sg->readyWriters);
+    WaitForSingleObject(hStart, INFINITE);
+
+    int size = sg->size > 0 ? sg->size : MAX_GRID;
+    uint32_t state = GetCurrentProcessId() * 2654435761u | 1;
+    for (int i = 0; i < updates; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        volatile LONG* cell = &sg->cells[(state >> 8) % size][(state >> 20) % size];
+        // Каждое обновление меняет значение клетки: 1 <-> 2
+        for (;;) {
+            LONG old = *cell;
+            LONG value = (old == 1) ? 2 : 1;
+            if (InterlockedCompareExchange(cell, value, old) == old)
+                break;
+        }
+        InterlockedIncrement(&sg->sequence);
+    }
+
+    CloseHandle(hStart);
+    CloseSharedGrid(sg, hMap);
+    return 0;
+}
+
+
+// =====================================================================
+// == ФУНКЦИЯ: Бенчмарк общей сетки: 1..N процессов-писателей        ==
+// =====================================================================
+void BenchmarkSharedGrid(int maxWriters) {
+    using clk = std::chrono::high_resolution_clock;
+    const int updatesPerWriter = 1000000;
+
+    // WaitForMultipleObjects ждёт не больше MAXIMUM_WAIT_OBJECTS дескрипторов
+    if (maxWriters > MAXIMUM_WAIT_OBJECTS) {
+        std::cerr << "[SharedGrid] writers limited to " << MAXIMUM_WAIT_OBJECTS << std::endl;
+        maxWriters = MAXIMUM_WAIT_OBJECTS;
+    }
+
+    HANDLE hMap = NULL;
+    SharedGrid* sg = OpenSharedGrid(sharedGridBenchName, MAX_GRID, hMap);
+    HANDLE hStart = CreateEventA(NULL, TRUE, FALSE, sharedGridStartEventName);
+    char exePath[MAX_PATH];
+    if (!sg || !hStart || !GetModuleFileNameA(NULL, exePath, MAX_PATH)) {
+        std::cerr << "[SharedGrid] setup failed: " << GetLastError() << std::endl;
+        if (hStart) CloseHandle(hStart);
+        CloseSharedGrid(sg, hMap);
+        return;
+    }
+
+    std::cout << u8"=== Бенчмарк общей сетки: " << updatesPerWriter
+        << u8" CAS-обновлений на процесс ===\n";
+
+    for (int writers = 1; writers <= maxWriters; ++writers) {
+        // 1) Запускаем писателей; они ждут стартового события
+        ResetEvent(hStart);
+        InterlockedExchange(&sg->readyWriters, 0);
+        // Счётчик между раундами переполняет LONG — считаем разницу без знака
+        ULONG seqBefore = static_cast<ULONG>(sg->sequence);
+        std::vector<HANDLE> processes;
+        for (int w = 0; w < writers; ++w) {
+            char cmd[MAX_PATH + 64];
+            sprintf_s(cmd, sizeof(cmd), "\"%s\" -shmwriter %d", exePath, updatesPerWriter);
+            STARTUPINFOA si = {};
+            si.cb = sizeof(si);
+            PROCESS_INFORMATION pi = {};
+            if (!CreateProcessA(NULL, cmd, NULL, NULL, FALSE, CREATE_NO_WINDOW,
+                NULL, NULL, &si, &pi)) {
+                std::cerr << "[SharedGrid] CreateProcess failed: " << GetLastError() << std::endl;
+                break;
+            }
+            CloseHandle(pi.hThread);
+            processes.push_back(pi.hProcess);
+        }
+        if (processes.empty())
+            break;
+
+        // Ждём, пока все писатели дойдут до ожидания события;
+        // писатель, завершившийся раньше, срывает раунд
+        const DWORD count = static_cast<DWORD>(processes.size());
+        bool ready = true;
+        while (static_cast<DWORD>(sg->readyWriters) < count) {
+            DWORD early = WaitForMultipleObjects(count, processes.data(), FALSE, 0);
+            if (early != WAIT_TIMEOUT) {
+                std::cerr << "[SharedGrid] writer exited before start" << std::endl;
+                ready = false;
+                break;
+            }
+            Sleep(1);
+        }
+        if (!ready) {
+            for (HANDLE h : processes) {
+                TerminateProcess(h, 1);
+                CloseHandle(h);
+            }
+            break;
+        }
+
+        // 2) Старт и ожидание завершения всех писателей
+        auto t0 = clk::now();
+        SetEvent(hStart);
+        DWORD wait = WaitForMultipleObjects(count, processes.data(), TRUE, INFINITE);
+        double ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+        if (wait == WAIT_FAILED) {
+            std::cerr << "[SharedGrid] WaitForMultipleObjects failed: " << GetLastError() << std::endl;
+            for (HANDLE h : processes) {
+                TerminateProcess(h, 1);
+                CloseHandle(h);
+            }
+            break;
+        }
+        for (HANDLE h : processes)
+            CloseHandle(h);
+
+        // 3) Счётчик должен вырасти ровно на число обновлений
+        ULONG applied = static_cast<ULONG>(sg->sequence) - seqBefore;
+        ULONG total = static_cast<ULONG>(processes.size()) * updatesPerWriter;
+        std::cout << u8"Писателей " << processes.size() << u8": " << ms << u8" ms, "
+            << (ms > 0 ? total * 1000.0 / ms : 0.0) << u8" обновлений/с"
+            << (applied == total ? u8"" : u8" (счётчик не совпал!)") << u8"\n";
+    }
+    std::cout << u8"\n";
+
+    CloseHandle(hStart);
+    CloseSharedGrid(sg, hMap);
 }
 
 
@@ -646,11 +2740,27 @@ LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT message, WPARAM wParam, LPARAM
         int col = x / cellW;
         int row = y / cellH;
         if (row >= 0 && row < gridSize && col >= 0 && col < gridSize) {
-            grid[row][col] = (message == WM_LBUTTONDOWN) ? 1 : 2;
+            int player = (message == WM_LBUTTONDOWN) ? 1 : 2;
+            // Ход, который не попал в сетку (журнал его отбросил), на доску не ставим
+            bool placed = SetCell(row, col, player) || GetCell(row, col) == player;
+            // Проверяем только линии через изменённую клетку
+            if (placed && gameBoard.Place(row, col, player, (std::min)(winLength, gridSize))) {
+                SetWindowText(hwnd, player == 1 ? _T("Победа: круги") : _T("Победа: крестики"));
+            }
             InvalidateRect(hwnd, NULL, FALSE);
         }
         return 0;
     }
+    case WM_TIMER:
+        // Общая сетка: перерисовываем, только если другой процесс что-то изменил
+        if (wParam == sharedGridTimerId && sharedGrid
+            && sharedGrid->sequence != sharedGridSeenSequence) {
+            sharedGridSeenSequence = sharedGrid->sequence;
+            if (RebuildGameBoard())
+                SetWindowText(hwnd, _T("Есть линия"));
+            InvalidateRect(hwnd, NULL, FALSE);
+        }
+        return 0;
     case WM_KEYDOWN:
         if (wParam == VK_ESCAPE
             || (wParam == 'Q' && (GetKeyState(VK_CONTROL) & 0x8000))) {
@@ -709,10 +2819,11 @@ LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT message, WPARAM wParam, LPARAM
             for (int c = 0; c < gridSize; ++c) {
                 int x0 = c * cw;
                 int y0 = r * ch;
-                if (grid[r][c] == 1) {
+                int cell = GetCell(r, c);
+                if (cell == 1) {
                     Ellipse(hdc, x0 + 5, y0 + 5, x0 + cw - 5, y0 + ch - 5);
                 }
-                else if (grid[r][c] == 2) {
+                else if (cell == 2) {
                     MoveToEx(hdc, x0 + 5, y0 + 5, NULL);
                     LineTo(hdc, x0 + cw - 5, y0 + ch - 5);
                     MoveToEx(hdc, x0 + cw - 5, y0 + 5, NULL);
@@ -750,17 +2861,58 @@ int _tmain(int argc, _TCHAR* argv[]) {
     SetConsoleOutputCP(CP_UTF8);
 
     int argSize = -1;
+    int smallFileCount = 0;   // -files N: бенчмарк N мелких файлов
+    bool runBitBoardBench = false; // -bitbench: бенчмарк битовой доски
+    bool useSharedGrid = false;    // -shm: общая сетка для нескольких процессов
+    int sharedBenchWriters = 0;    // -shmbench N: бенчмарк с 1..N писателями
+    int sharedWriterUpdates = 0;   // -shmwriter N: дочерний процесс бенчмарка
+    bool runJournalBench = false;  // -journalbench: бенчмарк журнала сетки
     for (int i = 1; i < argc; ++i) {
         if (_tcscmp(argv[i], _T("-m")) == 0 && i + 1 < argc) {
             configMethod = _ttoi(argv[++i]);
             if (configMethod < 1 || configMethod > 4)
                 configMethod = 2;
         }
+        else if (_tcscmp(argv[i], _T("-files")) == 0 && i + 1 < argc) {
+            smallFileCount = _ttoi(argv[++i]);
+        }
+        else if (_tcscmp(argv[i], _T("-k")) == 0 && i + 1 < argc) {
+            winLength = _ttoi(argv[++i]);
+            if (winLength < 1)
+                winLength = 5;
+        }
+        else if (_tcscmp(argv[i], _T("-bitbench")) == 0) {
+            runBitBoardBench = true;
+        }
+        else if (_tcscmp(argv[i], _T("-shm")) == 0) {
+            useSharedGrid = true;
+        }
+        else if (_tcscmp(argv[i], _T("-shmbench")) == 0 && i + 1 < argc) {
+            sharedBenchWriters = _ttoi(argv[++i]);
+        }
+        else if (_tcscmp(argv[i], _T("-shmwriter")) == 0 && i + 1 < argc) {
+            sharedWriterUpdates = _ttoi(argv[++i]);
+        }
+        else if (_tcscmp(argv[i], _T("-lock")) == 0) {
+            lockDataFile = true;
+        }
+        else if (_tcscmp(argv[i], _T("-journalbench")) == 0) {
+            runJournalBench = true;
+        }
+        else if (_tcscmp(argv[i], _T("-hp")) == 0) {
+            // Буферы чтения на больших страницах (если система позволяет)
+            if (!readBufferPool.EnableLargePages())
+                std::cerr << "[BufferPool] large pages unavailable, using normal pages" << std::endl;
+        }
         else {
             argSize = _ttoi(argv[i]);
         }
     }
 
+    // Дочерний процесс бенчмарка общей сетки: только пишет и выходит
+    if (sharedWriterUpdates > 0)
+        return RunSharedGridWriter(sharedWriterUpdates);
+
     bool ok = false;
     switch (configMethod) {
     case 1: ok = LoadConfig_Method1(); break;
@@ -774,6 +2926,34 @@ int _tmain(int argc, _TCHAR* argv[]) {
     }
 
     BenchmarkDataFile();
+    if (smallFileCount > 0)
+        BenchmarkSmallFiles(smallFileCount);
+    if (runBitBoardBench)
+        BenchmarkBitBoard();
+    if (sharedBenchWriters > 0)
+        BenchmarkSharedGrid(sharedBenchWriters);
+    if (runJournalBench)
+        BenchmarkGridJournal();
+
+    // Общая сетка: размер задаёт первый запущенный процесс
+    if (useSharedGrid) {
+        sharedGrid = OpenSharedGrid(sharedGridName, gridSize, hSharedGridMap);
+        if (sharedGrid) {
+            gridSize = sharedGrid->size;
+            sharedGridSeenSequence = sharedGrid->sequence;
+        }
+        else {
+            std::cerr << "[SharedGrid] mapping failed: " << GetLastError() << std::endl;
+        }
+    }
+    // Своя сетка: восстанавливаем её из образа и журнала и дальше журналируем клики.
+    // Общую сетку не журналируем — в один файл писали бы несколько процессов.
+    if (!sharedGrid && !gridJournal.Open(gridBaseFileName, gridJournalFileName, grid)) {
+        std::cerr << "[GridJournal] open failed: " << GetLastError() << std::endl;
+    }
+
+    // Битовая доска повторяет текущий размер и содержимое сетки
+    RebuildGameBoard();
 
     WNDCLASS wc = { 0 };
     wc.style = CS_HREDRAW | CS_VREDRAW;
@@ -796,11 +2976,17 @@ int _tmain(int argc, _TCHAR* argv[]) {
         NULL
     );
 
+    // Проверяем счётчик изменений общей сетки 20 раз в секунду
+    if (sharedGrid)
+        SetTimer(hwnd, sharedGridTimerId, 50, NULL);
+
     ShowWindow(hwnd, SW_SHOW);
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0)) {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+    gridJournal.Close();
+    CloseSharedGrid(sharedGrid, hSharedGridMap);
     return 0;
 }